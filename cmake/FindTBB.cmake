@@ -1,6 +1,8 @@
 set(TBB_FOUND TRUE)
 
 function(export_tbb_lib libname)
+	set(optional ${ARGN})
+
 	set(arch_prefix_void_p_4 "ia32")
 	set(arch_prefix_void_p_8 "intel64")
 	set(msvc_prefix_1700 "vc11")
@@ -10,23 +12,31 @@ function(export_tbb_lib libname)
 	set(lib_file_name "${CMAKE_STATIC_LIBRARY_PREFIX}${libname}${CMAKE_STATIC_LIBRARY_SUFFIX}")
 	if (MSVC)
 		set(lib_file "${TBB_ROOT}/lib/${arch_prefix_void_p_${CMAKE_SIZEOF_VOID_P}}/${msvc_prefix_${MSVC_VERSION}}/${lib_file_name}")
+	else()
+		find_library(${libname}_LIBRARY_PATH ${libname} HINTS "${TBB_ROOT}/lib")
+		set(lib_file "${${libname}_LIBRARY_PATH}")
 	endif()
 	
 	if (NOT EXISTS "${lib_file}")
-		set(TBB_FOUND FALSE PARENT_SCOPE)
+		# oneTBB no longer ships some of the libraries, only missing tbb itself is fatal there
+		if (MSVC OR NOT optional)
+			set(TBB_FOUND FALSE PARENT_SCOPE)
+		endif()
 		return()
 	endif()
 	
 	add_library(${libname} INTERFACE)
 	target_link_libraries     (${libname} INTERFACE "${lib_file}")
-	target_include_directories(${libname} INTERFACE "${TBB_ROOT}/include")
+	if (TBB_ROOT)
+		target_include_directories(${libname} INTERFACE "${TBB_ROOT}/include")
+	endif()
 endfunction()
 
 export_tbb_lib(tbb)
-export_tbb_lib(tbb_preview)
-export_tbb_lib(tbbmalloc)
-export_tbb_lib(tbbmalloc_proxy)
-export_tbb_lib(tbbproxy)
+export_tbb_lib(tbb_preview     OPTIONAL)
+export_tbb_lib(tbbmalloc       OPTIONAL)
+export_tbb_lib(tbbmalloc_proxy OPTIONAL)
+export_tbb_lib(tbbproxy        OPTIONAL)
 
 if(NOT ${TBB_FOUND})
 	message(WARNING "Tbb was not found")
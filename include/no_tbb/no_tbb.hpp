@@ -123,7 +123,7 @@ void parallel_for_each(iterator_t begin, iterator_t end, functor_t&& functor) {
 
     std::vector<std::future<void> > futures;
     for (size_t thread_id = 0; thread_id < num_threads; ++thread_id) {
-        iterator_t this_thread_begin = begin + num_elements_per_thread * thread_id;
+        iterator_t this_thread_begin = begin + std::min(num_elements_per_thread * thread_id,       num_elements);
         iterator_t this_thread_end   = begin + std::min(num_elements_per_thread * (1 + thread_id), num_elements);
 
         futures.emplace_back(p.async([this_thread_begin, this_thread_end, thread_id, functor]() -> void {
@@ -146,8 +146,8 @@ void parallel_for(size_t begin, size_t end, functor_t&& functor) {
 
     std::vector<std::future<void> > futures;
     for (size_t thread_id = 0; thread_id < num_threads; ++thread_id) {
-        size_t this_thread_begin = begin + num_elements_per_thread * thread_id;
-        size_t this_thread_end   = begin + std::min(num_elements_per_thread * (1 + thread_id), end);
+        size_t this_thread_begin = begin + std::min(num_elements_per_thread * thread_id,       num_elements);
+        size_t this_thread_end   = begin + std::min(num_elements_per_thread * (1 + thread_id), num_elements);
 
         futures.emplace_back(p.async([this_thread_begin, this_thread_end, thread_id, functor]() -> void {
             functor(thread_id, this_thread_begin, this_thread_end);
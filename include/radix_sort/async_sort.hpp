@@ -0,0 +1,186 @@
+#pragma once
+
+#include "detail/detail.hpp"
+#include "concurrent_sort.hpp"
+
+#include <algorithm>  // std::max
+#include <atomic>     // std::atomic
+#include <exception>  // std::exception_ptr
+#include <functional> // std::function
+#include <future>     // std::future, std::promise
+#include <iterator>   // std::iterator_traits<...>::value_type
+#include <memory>     // std::shared_ptr
+#include <mutex>      // std::mutex
+#include <vector>     // std::vector
+
+#include <cassert>
+
+#include <no_tbb/no_tbb.hpp>
+
+namespace radix_sort {
+namespace detail {
+
+// Parallel LSD radix sort expressed as a chain of no_tbb::thread_pool tasks. Every phase is
+// one task per chunk running a concurrent_radix_pass body, and the last task of a phase to
+// finish launches the next phase, so no pool worker ever blocks and the tasks of independent
+// sorts interleave in the pool queue.
+template<typename iterator_t>
+class async_sort_state : public std::enable_shared_from_this<async_sort_state<iterator_t> > {
+public:
+    typedef std::function<void(std::exception_ptr)> completion_type;
+
+    async_sort_state(iterator_t begin, iterator_t end, completion_type completion)
+        : _num_chunks(std::max<size_t>(no_tbb::thread_pool::instance().num_threads(), 1))
+        , _pass(begin, end, _num_chunks)
+        , _digit(0)
+        , _remaining(0)
+        , _completion(std::move(completion))
+    {}
+
+    void start() {
+        if (0 == _pass.num_elements) {
+            _completion(nullptr);
+            return;
+        }
+        if (_launch(count_phase)) {
+            _completion(_error);
+        }
+    }
+
+private:
+    typedef typename std::iterator_traits<iterator_t>::value_type value_type;
+    typedef radix_sort_helper<value_type> helper_type;
+
+    enum phase_type { count_phase, scatter_phase, copy_phase };
+
+    // Enqueues a task per chunk of `phase`. If enqueueing fails, the chunks which were not
+    // enqueued count as done and the error ends the sort once the enqueued ones finish.
+    // Returns true if that already happened, i.e. nothing of the phase is left running.
+    bool _launch(phase_type phase) {
+        std::shared_ptr<async_sort_state> self = this->shared_from_this();
+        no_tbb::thread_pool& p = no_tbb::thread_pool::instance();
+
+        _remaining.store(_num_chunks, std::memory_order_relaxed);
+        size_t num_launched = 0;
+        try {
+            for (; num_launched < _num_chunks; ++num_launched) {
+                size_t chunk_id = num_launched;
+                p.async([self, phase, chunk_id]() -> void {
+                    self->_run_chunk(phase, chunk_id);
+                    if (1 == self->_remaining.fetch_sub(1, std::memory_order_acq_rel)) {
+                        self->_phase_done(phase);
+                    }
+                });
+            }
+        } catch (...) {
+            _set_error(std::current_exception());
+            size_t num_skipped = _num_chunks - num_launched;
+            return num_skipped == _remaining.fetch_sub(num_skipped, std::memory_order_acq_rel);
+        }
+        return false;
+    }
+
+    void _set_error(std::exception_ptr error) {
+        std::lock_guard<std::mutex> lock(_error_access);
+        if (!_error) {
+            _error = error;
+        }
+    }
+
+    void _run_chunk(phase_type phase, size_t chunk_id) {
+        try {
+            size_t start, stop;
+            chunk_bounds(0, _pass.num_elements, _num_chunks, chunk_id, start, stop);
+
+            switch (phase) {
+            case count_phase:   _pass.count_chunk    (_digit, chunk_id, start, stop); break;
+            case scatter_phase: _pass.scatter_chunk  (_digit, chunk_id, start, stop); break;
+            case copy_phase:    _pass.copy_back_chunk(_digit, chunk_id, start, stop); break;
+            }
+        } catch (...) {
+            _set_error(std::current_exception());
+        }
+    }
+
+    // Runs on the thread which finished the last chunk of `phase`. The completion is called
+    // outside of the try block, so a throwing callback can not get called a second time.
+    void _phase_done(phase_type phase) {
+        std::exception_ptr error;
+        bool is_done = false;
+        try {
+            is_done = _next_phase(phase);
+        } catch (...) {
+            error = std::current_exception();
+            is_done = true;
+        }
+
+        if (is_done) {
+            _completion(error ? error : _error);
+        }
+    }
+
+    // Launches the phase following `phase`, returns true if the sort is over instead
+    bool _next_phase(phase_type phase) {
+        if (_error) {
+            return true;
+        }
+
+        if (scatter_phase == phase) {
+            ++_digit;
+            return _launch(copy_phase);
+        }
+
+        if (copy_phase == phase && _digit == helper_type::num_digits) {
+            return true;
+        }
+
+        // Histograms of _digit are ready. Skip the pass if all elements share the digit.
+        _pass.offsets_chunk(0, helper_type::num_buckets);
+        if (!_pass.map_buckets(_digit)) {
+            if (++_digit == helper_type::num_digits) {
+                return true;
+            }
+            return _launch(count_phase);
+        }
+
+        return _launch(scatter_phase);
+    }
+
+    const size_t                                      _num_chunks;
+    concurrent_radix_pass<helper_type, iterator_t>    _pass;
+    size_t                                            _digit;
+    std::atomic<size_t>                               _remaining;
+    completion_type                                   _completion;
+    std::mutex                                        _error_access;
+    std::exception_ptr                                _error;
+};
+
+}
+
+// Sorts [begin, end) on no_tbb::thread_pool without blocking the caller. `callback` is
+// called with a null std::exception_ptr on success, from a pool thread, or right away for
+// ranges with nothing to sort or if no task could be enqueued. Errors are reported only
+// after every enqueued task is over, so the range must stay valid until the callback.
+template<typename iterator_t, typename callback_t>
+void async_sort(iterator_t begin, iterator_t end, callback_t callback) {
+    assert(begin <= end);
+    typedef detail::async_sort_state<iterator_t> state_type;
+    std::make_shared<state_type>(begin, end, typename state_type::completion_type(std::move(callback)))->start();
+}
+
+// Same, but completion is signalled through a future. Do not wait on it from a pool worker.
+template<typename iterator_t>
+std::future<void> async_sort(iterator_t begin, iterator_t end) {
+    std::shared_ptr<std::promise<void> > promise = std::make_shared<std::promise<void> >();
+    std::future<void> result = promise->get_future();
+    async_sort(begin, end, [promise](std::exception_ptr error) -> void {
+        if (error) {
+            promise->set_exception(error);
+        } else {
+            promise->set_value();
+        }
+    });
+    return result;
+}
+
+}
@@ -1,86 +1,175 @@
 # pragma once
 
 #include "detail/detail.hpp"
+#include "executors/no_tbb_executor.hpp"
 
 #include <iterator> // std::iterator_traits<...>::value_type
 #include <vector>   // std::vector
 
-#include <no_tbb/no_tbb.hpp>
+#include <cassert>
 
 namespace radix_sort {
-    
-template<typename iterator_t>
-void concurrent_sort(iterator_t begin, iterator_t end) {
+
+namespace detail {
+
+// A single LSD pass split into per chunk bodies, shared by concurrent_sort, async_sort and
+// the grouping algorithms. The bodies can run on any thread, in any order within a phase,
+// as long as every thread id in [0, num_threads) gets the same chunk in every phase.
+template<typename helper_t, typename iterator_t>
+struct concurrent_radix_pass {
     typedef typename std::iterator_traits<iterator_t>::value_type value_type;
-    typedef detail::radix_sort_helper<value_type> helper_type;
-    typedef typename detail::radix_sort_helper<value_type>::radix_type radix_type;
-    
-    assert(begin <= end);
-    size_t num_elements = static_cast<size_t>(std::distance(begin, end));
+    typedef typename helper_t::radix_type radix_type;
+    typedef std::vector<no_init<value_type> > no_init_vector_type;
+    typedef std::vector<size_t> frequency_vec_t;
 
-    no_tbb::thread_pool& p = no_tbb::thread_pool::instance();
-    size_t num_threads = p.num_threads();
+    concurrent_radix_pass(iterator_t begin, iterator_t end, size_t num_threads)
+        : begin(begin)
+        , num_elements(static_cast<size_t>(std::distance(begin, end)))
+        , num_threads(num_threads)
+        , next_iter_array(num_elements)
+        , bucket_begins(helper_t::num_buckets)
+        , thread_data(num_threads, frequency_vec_t(helper_t::num_buckets))
+    {}
 
-    size_t aligned_num_elements = no_tbb::align(num_elements, num_threads);
-    size_t num_elements_per_thread = aligned_num_elements / num_threads;
+    // calculate per thread frequencies
+    void count_chunk(size_t digit, size_t thread_id, size_t start, size_t stop) {
+        frequency_vec_t& this_thread_data = thread_data[thread_id];
+        std::fill(this_thread_data.begin(), this_thread_data.end(), 0);
+        for (size_t jj = start; jj != stop; ++jj) {
+            this_thread_data[helper_t::digit(digit, begin[jj])]++;
+        }
+    }
 
-    typedef std::vector<detail::no_init<value_type> > no_init_vector_type;
-    no_init_vector_type next_iter_array(num_elements);
-    std::vector<size_t>     bucket_sizes(helper_type::num_buckets);
+    // conver frequencies of buckets [start, stop) to write offsets relative to the bucket
+    void offsets_chunk(size_t start, size_t stop) {
+        frequency_vec_t& bucket_sizes = bucket_begins;
+        for (size_t jj = start; jj != stop; ++jj) {
+            size_t current_sum = 0;
+            for (size_t kk = 0; kk < num_threads; ++kk) {
+                size_t next_sum = current_sum + thread_data[kk][jj];
+                thread_data[kk][jj] = current_sum;
+                current_sum = next_sum;
+            }
+            bucket_sizes[jj] = current_sum;
+        }
+    }
 
-    std::vector<typename no_init_vector_type::iterator > buckets;
-    buckets.reserve(helper_type::num_buckets);
-    typedef std::vector<size_t> frequency_vec_t;
+    // Map buckets to the next_iter_array. Runs once, after all the offsets_chunk calls.
+    // Returns false if all the elements share the digit, i.e. the pass would not move anything.
+    bool map_buckets(size_t digit) {
+        frequency_vec_t& bucket_sizes = bucket_begins;
+        bool is_trivial = 0 == num_elements || bucket_sizes[helper_t::digit(digit, begin[0])] == num_elements;
 
-    for (size_t ii = 0; ii < helper_type::num_digits; ++ii) {
-        std::vector<std::vector<size_t> > thread_data(num_threads, frequency_vec_t(helper_type::num_buckets));
+        size_t count = 0;
+        for (size_t jj = 0; jj < helper_t::num_buckets; ++jj) {
+            size_t bucket_size = bucket_sizes[jj];
+            bucket_begins[jj] = count;
+            count += bucket_size;
+        }
+        return !is_trivial;
+    }
 
-        // calculate per thread frequencies
-        no_tbb::parallel_for(0, num_elements, [&thread_data, ii, begin](size_t thread_id, size_t start, size_t stop) -> void {
-            for (size_t jj = start; jj != stop; ++jj) {
-                frequency_vec_t& this_thread_data = thread_data[thread_id];
-                this_thread_data[helper_type::digit(ii, begin[jj])]++;
-            }
-        });
-                
-        // conver frequencies to write offsets, resize buckets
-        no_tbb::parallel_for(0, helper_type::num_buckets, [&thread_data, &bucket_sizes, num_threads](size_t thread_id, size_t start, size_t stop) -> void {
+    // populate buckets
+    void scatter_chunk(size_t digit, size_t thread_id, size_t start, size_t stop) {
+        frequency_vec_t& this_thread_data = thread_data[thread_id];
+        for (size_t jj = start; jj != stop; ++jj) {
+            radix_type d = helper_t::digit(digit, begin[jj]);
+            size_t write_offset = bucket_begins[d] + this_thread_data[d]++;
+            next_iter_array[write_offset] = begin[jj];
+        }
+    }
+
+    // dump buckets back to the resulting buffer, counting the next digit of the same elements
+    // on the way, unless it was the last one
+    void copy_back_chunk(size_t next_digit, size_t thread_id, size_t start, size_t stop) {
+        if (next_digit == helper_t::num_digits) {
             for (size_t jj = start; jj != stop; ++jj) {
-                size_t current_sum = 0;
-                size_t next_sum = 0;
-                for (size_t kk = 0; kk < num_threads; ++kk) {
-                    size_t next_sum = current_sum + thread_data[kk][jj];
-                    thread_data[kk][jj] = current_sum;
-                    current_sum = next_sum;
-                }
-                bucket_sizes[jj] = current_sum;
+                begin[jj] = next_iter_array[jj];
             }
-        });
+            return;
+        }
 
-        // Map buckets to the next_iter_array
-        buckets.push_back(next_iter_array.begin());
-        for (size_t jj = 1; jj < helper_type::num_buckets; ++jj) {
-            buckets.push_back(buckets.back() + bucket_sizes[jj - 1]);
+        frequency_vec_t& this_thread_data = thread_data[thread_id];
+        std::fill(this_thread_data.begin(), this_thread_data.end(), 0);
+        for (size_t jj = start; jj != stop; ++jj) {
+            begin[jj] = next_iter_array[jj];
+            this_thread_data[helper_t::digit(next_digit, next_iter_array[jj])]++;
         }
+    }
 
-        // populate buckets
-        no_tbb::parallel_for(0, num_elements, [&thread_data, &buckets, ii, begin](size_t thread_id, size_t start, size_t stop) -> void {
-            for (size_t jj = start; jj != stop; ++jj) {
-                radix_type digit = helper_type::digit(ii, begin[jj]);
-                size_t write_offset = thread_data[thread_id][digit]++;
-                buckets[digit][write_offset] = begin[jj];
-            }
+    template<typename executor_t>
+    void count(const executor_t& executor, size_t digit) {
+        executor.parallel_for(0, num_elements, [this, digit](size_t thread_id, size_t start, size_t stop) -> void {
+            count_chunk(digit, thread_id, start, stop);
         });
+    }
 
-        // dump buckets back to the resulting buffer
-        no_tbb::parallel_for(0, num_elements, [begin, &next_iter_array](size_t thread_id, size_t start, size_t stop) -> void {
-            for (size_t jj = start; jj != stop; ++jj) {
-                begin[jj] = next_iter_array[jj];
-            }
+    template<typename executor_t>
+    bool offsets(const executor_t& executor, size_t digit) {
+        executor.parallel_for(0, helper_t::num_buckets, [this](size_t /*thread_id*/, size_t start, size_t stop) -> void {
+            offsets_chunk(start, stop);
+        });
+        return map_buckets(digit);
+    }
+
+    template<typename executor_t>
+    void scatter(const executor_t& executor, size_t digit) {
+        executor.parallel_for(0, num_elements, [this, digit](size_t thread_id, size_t start, size_t stop) -> void {
+            scatter_chunk(digit, thread_id, start, stop);
         });
+    }
 
-        buckets.clear();
+    template<typename executor_t>
+    void copy_back(const executor_t& executor, size_t next_digit) {
+        executor.parallel_for(0, num_elements, [this, next_digit](size_t thread_id, size_t start, size_t stop) -> void {
+            copy_back_chunk(next_digit, thread_id, start, stop);
+        });
     }
+
+    iterator_t                   begin;
+    size_t                       num_elements;
+    size_t                       num_threads;
+    no_init_vector_type          next_iter_array;
+    frequency_vec_t              bucket_begins;
+    std::vector<frequency_vec_t> thread_data;
+};
+
 }
-    
+
+// Parallel LSD radix sort on top of an executor. An executor provides:
+//
+//   size_t max_concurrency() const;
+//       Number of thread ids passed to parallel_for functors. The sort keeps a histogram
+//       per id, so an executor may hand out more ids than it has threads.
+//
+//   void parallel_for(size_t begin, size_t end, functor_t&& functor) const;
+//       Cuts [begin, end) into max_concurrency() contiguous, possibly empty, chunks and calls
+//       functor(thread_id, chunk_begin, chunk_end) for each of them. Chunk `k` must precede
+//       chunk `k + 1` and the cut must be the same for the same arguments, since the scatter
+//       phase relies on exactly the ranges seen by the histogram phase. Returns only after
+//       every chunk is done, i.e. it is the barrier between the sort phases.
+template<typename executor_t, typename iterator_t>
+void concurrent_sort(const executor_t& executor, iterator_t begin, iterator_t end) {
+    typedef typename std::iterator_traits<iterator_t>::value_type value_type;
+    typedef detail::radix_sort_helper<value_type> helper_type;
+
+    assert(begin <= end);
+    detail::concurrent_radix_pass<helper_type, iterator_t> pass(begin, end, executor.max_concurrency());
+
+    pass.count(executor, 0);
+    for (size_t ii = 0; ii < helper_type::num_digits; ++ii) {
+        if (pass.offsets(executor, ii)) {
+            pass.scatter(executor, ii);
+            pass.copy_back(executor, ii + 1);
+        } else if (ii + 1 < helper_type::num_digits) {
+            pass.count(executor, ii + 1);
+        }
+    }
+}
+
+template<typename iterator_t>
+void concurrent_sort(iterator_t begin, iterator_t end) {
+    concurrent_sort(no_tbb_executor(), begin, end);
+}
+
 }
@@ -1,29 +1,204 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <limits>
+#include <tuple>
 #include <type_traits>
+#include <utility>
 
 #include <cstdlib>
 #include <cstdint>
+#include <cstring>
 
 
 namespace radix_sort {
 namespace detail {
-template<typename value_t, typename radix_t = uint8_t>
+#if defined(__SIZEOF_INT128__)
+__extension__ typedef          __int128 int128_t;
+__extension__ typedef unsigned __int128 uint128_t;
+#endif
+
+template<typename value_t, typename enable_t = void>
+struct integer_traits {
+    static constexpr bool is_integer = false;
+};
+
+template<typename value_t>
+struct integer_traits<value_t, typename std::enable_if<std::is_integral<value_t>::value && !std::is_same<value_t, bool>::value>::type> {
+    static constexpr bool is_integer = true;
+    static constexpr bool is_signed  = std::is_signed<value_t>::value;
+    typedef typename std::make_unsigned<value_t>::type unsigned_type;
+};
+
+#if defined(__SIZEOF_INT128__)
+// Not std::is_integral in strict ISO mode
+template<>
+struct integer_traits<int128_t> {
+    static constexpr bool is_integer = true;
+    static constexpr bool is_signed  = true;
+    typedef uint128_t unsigned_type;
+};
+
+template<>
+struct integer_traits<uint128_t> {
+    static constexpr bool is_integer = true;
+    static constexpr bool is_signed  = false;
+    typedef uint128_t unsigned_type;
+};
+#endif
+
+// Splits a key into `num_bytes` bytes, byte 0 being the least significant one, such that
+// comparing the byte strings from the most significant byte down gives the order of the keys.
+template<typename value_t, typename enable_t = void>
+struct key_traits;
+
+// Integers: the value itself, with the sign bit flipped for signed types.
+template<typename value_t>
+struct key_traits<value_t, typename std::enable_if<integer_traits<value_t>::is_integer>::type> {
+    typedef typename integer_traits<value_t>::unsigned_type unsigned_type;
+    static constexpr size_t num_bytes = sizeof(value_t);
+
+    static uint8_t byte(size_t num, const value_t& value) {
+        unsigned_type bits = static_cast<unsigned_type>(value);
+        if (integer_traits<value_t>::is_signed) {
+            bits ^= static_cast<unsigned_type>(1) << (8 * num_bytes - 1);
+        }
+        return static_cast<uint8_t>(bits >> (8 * num));
+    }
+};
+
+// IEEE floats: negative values have all bits flipped, positive ones only the sign bit.
+// -0.0 gets the digits of +0.0, the two compare equal.
+template<typename value_t>
+struct key_traits<value_t, typename std::enable_if<std::is_floating_point<value_t>::value && (sizeof(value_t) == 4 || sizeof(value_t) == 8)>::type> {
+    typedef typename std::conditional<sizeof(value_t) == 4, uint32_t, uint64_t>::type unsigned_type;
+    static constexpr size_t num_bytes = sizeof(value_t);
+
+    static uint8_t byte(size_t num, const value_t& value) {
+        unsigned_type bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        const unsigned_type sign_bit = static_cast<unsigned_type>(1) << (8 * num_bytes - 1);
+        if (bits == sign_bit) {
+            bits = 0;
+        }
+        bits = (bits & sign_bit) ? ~bits : (bits ^ sign_bit);
+        return static_cast<uint8_t>(bits >> (8 * num));
+    }
+};
+
+// Fixed size arrays compare lexicographically, element 0 is the most significant one.
+template<typename field_t, size_t size>
+struct key_traits<std::array<field_t, size> > {
+    typedef key_traits<field_t> field_traits;
+    static constexpr size_t num_bytes = size * field_traits::num_bytes;
+
+    static uint8_t byte(size_t num, const std::array<field_t, size>& value) {
+        return field_traits::byte(num % field_traits::num_bytes, value[size - 1 - num / field_traits::num_bytes]);
+    }
+};
+
+template<typename first_t, typename second_t>
+struct key_traits<std::pair<first_t, second_t> > {
+    typedef key_traits<first_t>  first_traits;
+    typedef key_traits<second_t> second_traits;
+    static constexpr size_t num_bytes = first_traits::num_bytes + second_traits::num_bytes;
+
+    static uint8_t byte(size_t num, const std::pair<first_t, second_t>& value) {
+        return num < second_traits::num_bytes ?
+            second_traits::byte(num, value.second) :
+            first_traits::byte(num - second_traits::num_bytes, value.first);
+    }
+};
+
+// The first `num_fields` fields of a tuple, the last of them being the least significant one.
+template<typename tuple_t, size_t num_fields>
+struct tuple_key_traits {
+    typedef typename std::tuple_element<num_fields - 1, tuple_t>::type field_type;
+    typedef key_traits<field_type> field_traits;
+    typedef tuple_key_traits<tuple_t, num_fields - 1> prefix_traits;
+    static constexpr size_t num_bytes = prefix_traits::num_bytes + field_traits::num_bytes;
+
+    static uint8_t byte(size_t num, const tuple_t& value) {
+        return num < field_traits::num_bytes ?
+            field_traits::byte(num, std::get<num_fields - 1>(value)) :
+            prefix_traits::byte(num - field_traits::num_bytes, value);
+    }
+};
+
+template<typename tuple_t>
+struct tuple_key_traits<tuple_t, 0> {
+    static constexpr size_t num_bytes = 0;
+    static uint8_t byte(size_t, const tuple_t&) { return 0; }
+};
+
+template<typename... fields_t>
+struct key_traits<std::tuple<fields_t...> > : tuple_key_traits<std::tuple<fields_t...>, sizeof...(fields_t)> {};
+
+// Strict weak order consistent with the digits of key_traits, e.g. for merging sorted runs.
+template<typename value_t, typename enable_t = void>
+struct key_less {
+    typedef key_traits<value_t> key_traits_type;
+
+    bool operator()(const value_t& lhs, const value_t& rhs) const {
+        for (size_t num = key_traits_type::num_bytes; num-- > 0; ) {
+            uint8_t lhs_byte = key_traits_type::byte(num, lhs);
+            uint8_t rhs_byte = key_traits_type::byte(num, rhs);
+            if (lhs_byte != rhs_byte) {
+                return lhs_byte < rhs_byte;
+            }
+        }
+        return false;
+    }
+};
+
+template<typename value_t>
+struct key_less<value_t, typename std::enable_if<integer_traits<value_t>::is_integer>::type> {
+    bool operator()(const value_t& lhs, const value_t& rhs) const { return lhs < rhs; }
+};
+
+// Orders pairs by their first member only, for key-value sorts.
+template<typename pair_t>
+struct first_key_traits {
+    typedef key_traits<typename pair_t::first_type> first_traits;
+    static constexpr size_t num_bytes = first_traits::num_bytes;
+
+    static uint8_t byte(size_t num, const pair_t& value) {
+        return first_traits::byte(num, value.first);
+    }
+};
+
+template<typename value_t, typename radix_t = uint8_t, typename key_traits_t = key_traits<value_t> >
 struct radix_sort_helper {
     typedef value_t value_type;
     typedef radix_t radix_type;
-    static constexpr size_t     num_digits = sizeof(value_type) / sizeof(radix_type);
+    typedef key_traits_t key_traits_type;
+    static constexpr size_t     num_digits = (key_traits_type::num_bytes + sizeof(radix_type) - 1) / sizeof(radix_type);
     static constexpr size_t     bits_per_digit = sizeof(radix_type) * 8;
     static constexpr radix_type max_digit = std::numeric_limits<radix_type>::max();
-    static constexpr size_t     num_buckets = max_digit + 1;
+    static constexpr size_t     num_buckets = static_cast<size_t>(max_digit) + 1;
 
-    static radix_type digit(size_t num, value_type value) {
-        const size_t bit_shift = bits_per_digit * num;
-        return max_digit & (value >> bit_shift);
+    static radix_type digit(size_t num, const value_type& value) {
+        radix_type result = 0;
+        for (size_t ii = 0; ii < sizeof(radix_type); ++ii) {
+            size_t byte_num = num * sizeof(radix_type) + ii;
+            if (byte_num < key_traits_type::num_bytes) {
+                result |= static_cast<radix_type>(static_cast<radix_type>(key_traits_type::byte(byte_num, value)) << (8 * ii));
+            }
+        }
+        return result;
     }
 };
 
+// Bounds of the `chunk_id`-th of `num_chunks` contiguous, ordered pieces of [begin, end).
+// Trailing chunks may be empty when there are fewer elements than chunks.
+inline void chunk_bounds(size_t begin, size_t end, size_t num_chunks, size_t chunk_id, size_t& chunk_begin, size_t& chunk_end) {
+    size_t num_elements = end - begin;
+    size_t num_elements_per_chunk = (num_elements + num_chunks - 1) / num_chunks;
+    chunk_begin = begin + std::min(num_elements_per_chunk * chunk_id,       num_elements);
+    chunk_end   = begin + std::min(num_elements_per_chunk * (1 + chunk_id), num_elements);
+}
+
 template<typename value_t>
 struct no_init {
     no_init() {
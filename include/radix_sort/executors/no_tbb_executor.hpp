@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdlib>
+#include <utility>
+
+#include <no_tbb/no_tbb.hpp>
+
+namespace radix_sort {
+
+// Runs on the process-wide no_tbb::thread_pool.
+struct no_tbb_executor {
+    size_t max_concurrency() const { return no_tbb::thread_pool::instance().num_threads(); }
+
+    template<typename functor_t>
+    void parallel_for(size_t begin, size_t end, functor_t&& functor) const {
+        no_tbb::parallel_for(begin, end, std::forward<functor_t>(functor));
+    }
+};
+
+}
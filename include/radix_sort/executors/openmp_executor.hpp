@@ -0,0 +1,32 @@
+#pragma once
+
+#if defined(_OPENMP)
+
+#include <cstdlib>
+
+#include <omp.h>
+
+#include "../detail/detail.hpp"
+
+namespace radix_sort {
+
+// Runs on the OpenMP runtime, one static chunk per thread of the team.
+struct openmp_executor {
+    size_t max_concurrency() const { return static_cast<size_t>(omp_get_max_threads()); }
+
+    template<typename functor_t>
+    void parallel_for(size_t begin, size_t end, functor_t&& functor) const {
+        // MSVC only supports OpenMP 2.0, which requires a signed loop counter.
+        const long num_chunks = static_cast<long>(max_concurrency());
+#pragma omp parallel for schedule(static, 1) num_threads(num_chunks)
+        for (long chunk_id = 0; chunk_id < num_chunks; ++chunk_id) {
+            size_t chunk_begin, chunk_end;
+            detail::chunk_bounds(begin, end, static_cast<size_t>(num_chunks), static_cast<size_t>(chunk_id), chunk_begin, chunk_end);
+            functor(static_cast<size_t>(chunk_id), chunk_begin, chunk_end);
+        }
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdlib>
+
+namespace radix_sort {
+
+// Runs everything on the calling thread. Mostly useful as a baseline and for debugging.
+struct serial_executor {
+    size_t max_concurrency() const { return 1; }
+
+    template<typename functor_t>
+    void parallel_for(size_t begin, size_t end, functor_t&& functor) const {
+        functor(0, begin, end);
+    }
+};
+
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#if defined(TBB_FOUND)
+
+#include <algorithm>
+#include <cstdlib>
+
+#include <tbb/parallel_for.h>
+#include <tbb/partitioner.h>
+#include <tbb/task_arena.h>
+
+#include "../detail/detail.hpp"
+
+namespace radix_sort {
+
+// Runs on TBB without creating an arena of its own: on the arena given to the constructor,
+// or else on the one of the calling thread, so it is safe to use from inside tbb::parallel_for
+// bodies and nested sorts share the workers of the enclosing algorithm.
+//
+// The range is cut into `chunks_per_thread` chunks per arena slot up front, and the chunk index
+// (not this_task_arena::current_thread_index()) is what the functor receives as thread id, so
+// the sort keeps one histogram per chunk. Chunks are distributed by `partitioner_t`; with the
+// default auto_partitioner idle workers steal chunks from slow ones instead of waiting for them.
+// `chunks_per_thread` of 0 is treated as 1, the sort needs at least one chunk per slot.
+template<typename partitioner_t = tbb::auto_partitioner>
+struct basic_tbb_executor {
+    explicit basic_tbb_executor(size_t chunks_per_thread = 4, tbb::task_arena* arena = nullptr)
+        : _chunks_per_thread(std::max<size_t>(chunks_per_thread, 1))
+        , _arena(arena)
+    {}
+
+    size_t max_concurrency() const {
+        int num_threads = _arena ? _arena->max_concurrency() : tbb::this_task_arena::max_concurrency();
+        return _chunks_per_thread * static_cast<size_t>(num_threads);
+    }
+
+    template<typename functor_t>
+    void parallel_for(size_t begin, size_t end, functor_t&& functor) const {
+        const size_t num_chunks = max_concurrency();
+        auto body = [begin, end, num_chunks, &functor]() -> void {
+            partitioner_t partitioner;
+            tbb::parallel_for(static_cast<size_t>(0), num_chunks, [begin, end, num_chunks, &functor](size_t chunk_id) -> void {
+                size_t chunk_begin, chunk_end;
+                detail::chunk_bounds(begin, end, num_chunks, chunk_id, chunk_begin, chunk_end);
+                functor(chunk_id, chunk_begin, chunk_end);
+            }, partitioner);
+        };
+
+        if (_arena) {
+            _arena->execute(body);
+        } else {
+            body();
+        }
+    }
+
+private:
+    size_t           _chunks_per_thread;
+    tbb::task_arena* _arena;
+};
+
+typedef basic_tbb_executor<> tbb_executor;
+
+}
+
+#endif
@@ -0,0 +1,310 @@
+#pragma once
+
+#include "detail/detail.hpp"
+#include "sort.hpp"
+#include "concurrent_sort.hpp"
+#include "executors/no_tbb_executor.hpp"
+
+#include <algorithm> // std::copy
+#include <iterator>  // std::iterator_traits<...>::value_type
+#include <utility>   // std::pair
+#include <vector>    // std::vector
+
+#include <cassert>
+
+namespace radix_sort {
+namespace detail {
+
+// A grouping policy tells the grouping sorts which elements form a group and how to fold them:
+//
+//   bool same_key(const value_type& group, const value_type& value) const;
+//       Keys are compared with operator==, as std::unique does, so -0.0 and +0.0 are the same
+//       key (key_traits gives them the same digits, so they end up next to each other).
+//   void accumulate(value_type& group, const value_type& value);
+//       `value` joins `group`. May be called concurrently for different groups.
+//   void emit(size_t group_index, size_t count);
+//       The `group_index`-th group of the output is closed and has `count` elements.
+//       Possibly called concurrently and out of order.
+
+template<typename value_t>
+struct unique_policy {
+    bool same_key(const value_t& group, const value_t& value) const { return group == value; }
+    void accumulate(value_t&, const value_t&) {}
+    void emit(size_t, size_t) {}
+};
+
+template<typename value_t, typename counts_iterator_t>
+struct count_policy : unique_policy<value_t> {
+    explicit count_policy(counts_iterator_t counts) : counts_begin(counts) {}
+
+    void emit(size_t group_index, size_t count) { counts_begin[group_index] = count; }
+
+    counts_iterator_t counts_begin;
+};
+
+template<typename pair_t, typename reduce_t>
+struct reduce_policy {
+    explicit reduce_policy(reduce_t reduce) : reduce(reduce) {}
+
+    bool same_key(const pair_t& group, const pair_t& value) const { return group.first == value.first; }
+    void accumulate(pair_t& group, const pair_t& value) { group.second = reduce(group.second, value.second); }
+    void emit(size_t, size_t) {}
+
+    reduce_t reduce;
+};
+
+// Folds the sorted, non empty [source, source + num_elements) into `output`, one element per
+// group, emitting every group as it closes. `source` may be `output` itself. Returns the end
+// of the groups.
+template<typename value_t, typename source_t, typename iterator_t, typename policy_t>
+iterator_t fold_groups(source_t source, size_t num_elements, iterator_t output, policy_t& policy) {
+    size_t group_index = 0;
+    size_t group_begin = 0;
+    value_t group = source[0];
+    for (size_t jj = 1; jj != num_elements; ++jj) {
+        const value_t& value = source[jj];
+        if (policy.same_key(group, value)) {
+            policy.accumulate(group, value);
+        } else {
+            output[group_index] = group;
+            policy.emit(group_index++, jj - group_begin);
+            group = value;
+            group_begin = jj;
+        }
+    }
+    output[group_index] = group;
+    policy.emit(group_index++, num_elements - group_begin);
+    return output + group_index;
+}
+
+// radix_sort::sort, with the copy back of the last pass that moves anything folding equal keys
+// instead. Returns the end of the groups.
+template<typename helper_t, typename iterator_t, typename policy_t>
+iterator_t sort_and_group(iterator_t begin, iterator_t end, policy_t& policy) {
+    typedef typename std::iterator_traits<iterator_t>::value_type value_type;
+    static_assert(helper_t::num_digits > 0, "Keys without digits can not be grouped");
+
+    assert(begin <= end);
+    size_t num_elements = static_cast<size_t>(std::distance(begin, end));
+    if (0 == num_elements) {
+        return end;
+    }
+
+    typedef std::vector<no_init<value_type> > no_init_vector_type;
+    no_init_vector_type next_iter_array(num_elements);
+
+    std::vector<size_t> frequencies = digit_histograms<helper_t>(begin, num_elements);
+
+    size_t num_moving_digits = 0;
+    for (size_t ii = 0; ii < helper_t::num_digits; ++ii) {
+        if (moves_anything<helper_t>(&frequencies[ii * helper_t::num_buckets], ii, begin, num_elements)) {
+            num_moving_digits++;
+        }
+    }
+
+    // All the elements have the same digits, fold them where they are
+    if (0 == num_moving_digits) {
+        return fold_groups<value_type>(begin, num_elements, begin, policy);
+    }
+
+    for (size_t ii = 0; ii < helper_t::num_digits; ++ii) {
+        size_t* frequency = &frequencies[ii * helper_t::num_buckets];
+        if (!moves_anything<helper_t>(frequency, ii, begin, num_elements)) {
+            continue;
+        }
+
+        frequencies_to_offsets<helper_t>(frequency);
+        for (size_t jj = 0; jj != num_elements; ++jj) {
+            auto d = helper_t::digit(ii, begin[jj]);
+            next_iter_array[frequency[d]] = begin[jj];
+            frequency[d]++;
+        }
+
+        if (0 == --num_moving_digits) {
+            break;
+        }
+        std::copy(next_iter_array.begin(), next_iter_array.end(), begin);
+    }
+
+    return fold_groups<value_type>(next_iter_array.begin(), num_elements, begin, policy);
+}
+
+// concurrent_sort, with the copy back of the last pass that moves anything folding equal keys
+// instead. Every thread counts the groups starting in its chunk, and then folds them to their
+// place in [begin, end), following the last one of them into the next chunks if necessary.
+// Returns the end of the groups.
+template<typename helper_t, typename executor_t, typename iterator_t, typename policy_t>
+iterator_t concurrent_sort_and_group(const executor_t& executor, iterator_t begin, iterator_t end, policy_t& policy) {
+    typedef concurrent_radix_pass<helper_t, iterator_t> pass_type;
+    typedef typename pass_type::value_type value_type;
+    typedef typename pass_type::frequency_vec_t frequency_vec_t;
+    static_assert(helper_t::num_digits > 0, "Keys without digits can not be grouped");
+
+    assert(begin <= end);
+    if (begin == end) {
+        return end;
+    }
+
+    pass_type pass(begin, end, executor.max_concurrency());
+
+    // count digit 0, and find the digits which differ from the ones of the first element
+    std::vector<std::vector<char> > moving_digits(pass.num_threads, std::vector<char>(helper_t::num_digits));
+    executor.parallel_for(0, pass.num_elements, [&pass, &moving_digits](size_t thread_id, size_t start, size_t stop) -> void {
+        pass.count_chunk(0, thread_id, start, stop);
+        for (size_t ii = 0; ii < helper_t::num_digits; ++ii) {
+            auto first_digit = helper_t::digit(ii, pass.begin[0]);
+            for (size_t jj = start; jj != stop; ++jj) {
+                if (helper_t::digit(ii, pass.begin[jj]) != first_digit) {
+                    moving_digits[thread_id][ii] = 1;
+                    break;
+                }
+            }
+        }
+    });
+
+    size_t num_moving_digits = 0;
+    for (size_t ii = 0; ii < helper_t::num_digits; ++ii) {
+        for (size_t kk = 0; kk < pass.num_threads; ++kk) {
+            if (moving_digits[kk][ii]) {
+                num_moving_digits++;
+                break;
+            }
+        }
+    }
+
+    // All the elements have the same digits, fold them where they are
+    if (0 == num_moving_digits) {
+        return fold_groups<value_type>(begin, pass.num_elements, begin, policy);
+    }
+
+    for (size_t ii = 0; ii < helper_t::num_digits; ++ii) {
+        if (pass.offsets(executor, ii)) {
+            pass.scatter(executor, ii);
+            if (0 == --num_moving_digits) {
+                break;
+            }
+            pass.copy_back(executor, ii + 1);
+        } else {
+            pass.count(executor, ii + 1);
+        }
+    }
+
+    const no_init<value_type>* sorted = pass.next_iter_array.data();
+    auto is_group_head = [sorted, &policy](size_t index) -> bool {
+        return 0 == index || !policy.same_key(sorted[index - 1], sorted[index]);
+    };
+
+    // count groups starting in every chunk
+    frequency_vec_t group_begins(pass.num_threads);
+    executor.parallel_for(0, pass.num_elements, [&group_begins, &is_group_head](size_t thread_id, size_t start, size_t stop) -> void {
+        size_t num_groups = 0;
+        for (size_t jj = start; jj != stop; ++jj) {
+            num_groups += is_group_head(jj) ? 1 : 0;
+        }
+        group_begins[thread_id] = num_groups;
+    });
+
+    size_t num_groups = 0;
+    for (size_t kk = 0; kk < pass.num_threads; ++kk) {
+        size_t chunk_groups = group_begins[kk];
+        group_begins[kk] = num_groups;
+        num_groups += chunk_groups;
+    }
+
+    // fold groups back to the resulting buffer
+    executor.parallel_for(0, pass.num_elements, [&pass, sorted, &group_begins, &is_group_head, &policy](size_t thread_id, size_t start, size_t stop) -> void {
+        size_t jj = start;
+        while (jj != stop && !is_group_head(jj)) {
+            jj++;
+        }
+
+        size_t group_index = group_begins[thread_id];
+        while (jj < stop) {
+            value_type group = sorted[jj];
+            size_t group_end = jj + 1;
+            for (; group_end != pass.num_elements && !is_group_head(group_end); ++group_end) {
+                policy.accumulate(group, sorted[group_end]);
+            }
+            pass.begin[group_index] = group;
+            policy.emit(group_index, group_end - jj);
+            group_index++;
+            jj = group_end;
+        }
+    });
+
+    return begin + num_groups;
+}
+
+}
+
+// Sorts [begin, end) and removes duplicates, like std::sort followed by std::unique but
+// without the extra pass. Returns the new end of the range.
+template<typename iterator_t>
+iterator_t unique(iterator_t begin, iterator_t end) {
+    typedef typename std::iterator_traits<iterator_t>::value_type value_type;
+    typedef detail::radix_sort_helper<value_type> helper_type;
+    detail::unique_policy<value_type> policy;
+    return detail::sort_and_group<helper_type>(begin, end, policy);
+}
+
+template<typename executor_t, typename iterator_t>
+iterator_t concurrent_unique(const executor_t& executor, iterator_t begin, iterator_t end) {
+    typedef typename std::iterator_traits<iterator_t>::value_type value_type;
+    typedef detail::radix_sort_helper<value_type> helper_type;
+    detail::unique_policy<value_type> policy;
+    return detail::concurrent_sort_and_group<helper_type>(executor, begin, end, policy);
+}
+
+template<typename iterator_t>
+iterator_t concurrent_unique(iterator_t begin, iterator_t end) {
+    return concurrent_unique(no_tbb_executor(), begin, end);
+}
+
+// Same as unique, and writes the number of occurrences of each distinct key to `counts`,
+// a random access iterator with room for as many counts as there are distinct keys.
+template<typename iterator_t, typename counts_iterator_t>
+iterator_t count_by_key(iterator_t begin, iterator_t end, counts_iterator_t counts) {
+    typedef typename std::iterator_traits<iterator_t>::value_type value_type;
+    typedef detail::radix_sort_helper<value_type> helper_type;
+    detail::count_policy<value_type, counts_iterator_t> policy(counts);
+    return detail::sort_and_group<helper_type>(begin, end, policy);
+}
+
+template<typename executor_t, typename iterator_t, typename counts_iterator_t>
+iterator_t concurrent_count_by_key(const executor_t& executor, iterator_t begin, iterator_t end, counts_iterator_t counts) {
+    typedef typename std::iterator_traits<iterator_t>::value_type value_type;
+    typedef detail::radix_sort_helper<value_type> helper_type;
+    detail::count_policy<value_type, counts_iterator_t> policy(counts);
+    return detail::concurrent_sort_and_group<helper_type>(executor, begin, end, policy);
+}
+
+template<typename iterator_t, typename counts_iterator_t>
+iterator_t concurrent_count_by_key(iterator_t begin, iterator_t end, counts_iterator_t counts) {
+    return concurrent_count_by_key(no_tbb_executor(), begin, end, counts);
+}
+
+// Sorts a range of std::pair by `first` and folds the `second`s of equal keys left to right
+// with `reduce(accumulated, next)`, keeping one pair per key. Returns the new end of the range.
+// The concurrent versions call `reduce` from several threads at once.
+template<typename iterator_t, typename reduce_t>
+iterator_t reduce_by_key(iterator_t begin, iterator_t end, reduce_t reduce) {
+    typedef typename std::iterator_traits<iterator_t>::value_type value_type;
+    typedef detail::radix_sort_helper<value_type, uint8_t, detail::first_key_traits<value_type> > helper_type;
+    detail::reduce_policy<value_type, reduce_t> policy(reduce);
+    return detail::sort_and_group<helper_type>(begin, end, policy);
+}
+
+template<typename executor_t, typename iterator_t, typename reduce_t>
+iterator_t concurrent_reduce_by_key(const executor_t& executor, iterator_t begin, iterator_t end, reduce_t reduce) {
+    typedef typename std::iterator_traits<iterator_t>::value_type value_type;
+    typedef detail::radix_sort_helper<value_type, uint8_t, detail::first_key_traits<value_type> > helper_type;
+    detail::reduce_policy<value_type, reduce_t> policy(reduce);
+    return detail::concurrent_sort_and_group<helper_type>(executor, begin, end, policy);
+}
+
+template<typename iterator_t, typename reduce_t>
+iterator_t concurrent_reduce_by_key(iterator_t begin, iterator_t end, reduce_t reduce) {
+    return concurrent_reduce_by_key(no_tbb_executor(), begin, end, reduce);
+}
+
+}
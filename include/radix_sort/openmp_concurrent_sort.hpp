@@ -0,0 +1,17 @@
+#pragma once
+
+#if defined(_OPENMP)
+
+#include "concurrent_sort.hpp"
+#include "executors/openmp_executor.hpp"
+
+namespace radix_sort {
+
+template<typename iterator_t>
+void openmp_concurrent_sort(iterator_t begin, iterator_t end) {
+    concurrent_sort(openmp_executor(), begin, end);
+}
+
+}
+
+#endif
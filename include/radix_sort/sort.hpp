@@ -8,6 +8,39 @@
 #include <cassert>  
 
 namespace radix_sort {
+namespace detail {
+
+// Histograms of all digits, collected in a single pass over the data
+template<typename helper_t, typename iterator_t>
+std::vector<size_t> digit_histograms(iterator_t begin, size_t num_elements) {
+    std::vector<size_t> frequencies(helper_t::num_digits * helper_t::num_buckets);
+    for (size_t jj = 0; jj != num_elements; ++jj) {
+        for (size_t ii = 0; ii < helper_t::num_digits; ++ii) {
+            frequencies[ii * helper_t::num_buckets + helper_t::digit(ii, begin[jj])]++;
+        }
+    }
+    return frequencies;
+}
+
+// False if all elements share the digit, i.e. the pass would not move anything
+template<typename helper_t, typename iterator_t>
+bool moves_anything(const size_t* frequency, size_t digit, iterator_t begin, size_t num_elements) {
+    return num_elements != 0 && frequency[helper_t::digit(digit, begin[0])] != num_elements;
+}
+
+// Turns a histogram into write offsets of the buckets
+template<typename helper_t>
+void frequencies_to_offsets(size_t* frequency) {
+    size_t count = 0;
+    for (size_t jj = 0; jj < helper_t::num_buckets; ++jj) {
+        size_t prev_freq = frequency[jj];
+        frequency[jj] = count;
+        count += prev_freq;
+    }
+}
+
+}
+
 template<typename iterator_t>
 void sort(iterator_t begin, iterator_t end) {
     typedef typename std::iterator_traits<iterator_t>::value_type value_type;
@@ -19,19 +52,15 @@ void sort(iterator_t begin, iterator_t end) {
     typedef std::vector<detail::no_init<value_type> > no_init_vector_type;
     no_init_vector_type next_iter_array(num_elements);
 
-    for (size_t ii = 0; ii < helper_type::num_digits; ++ii) {
-        std::vector<size_t> frequency(helper_type::num_buckets);
+    std::vector<size_t> frequencies = detail::digit_histograms<helper_type>(begin, num_elements);
 
-        for (size_t jj = 0; jj != num_elements; ++jj) {
-            frequency[helper_type::digit(ii, begin[jj])]++;
+    for (size_t ii = 0; ii < helper_type::num_digits; ++ii) {
+        size_t* frequency = &frequencies[ii * helper_type::num_buckets];
+        if (!detail::moves_anything<helper_type>(frequency, ii, begin, num_elements)) {
+            continue;
         }
 
-        size_t count = 0;
-        for (size_t jj = 0; jj < helper_type::num_buckets; ++jj) {
-            size_t prev_freq = frequency[jj];
-            frequency[jj] = count;
-            count += prev_freq;
-        }
+        detail::frequencies_to_offsets<helper_type>(frequency);
 
         for (size_t jj = 0; jj != num_elements; ++jj) {
             auto d = helper_type::digit(ii, begin[jj]);
@@ -0,0 +1,174 @@
+#pragma once
+
+#include "detail/detail.hpp"
+#include "sort.hpp"
+
+#include <algorithm> // std::push_heap, std::pop_heap
+#include <deque>     // std::deque
+#include <future>    // std::future
+#include <iterator>  // std::input_iterator_tag
+#include <memory>    // std::unique_ptr
+#include <vector>    // std::vector
+
+#include <cassert>
+
+#include <no_tbb/no_tbb.hpp>
+
+namespace radix_sort {
+
+// Sorts data that arrives in chunks. Pushed elements are cut into runs of `run_size`
+// elements which are radix sorted on no_tbb::thread_pool while the caller keeps pushing,
+// after finish() the runs are k-way merged lazily, as the sorted sequence is iterated.
+//
+// At most one run per pool thread is sorted at a time, push() blocks while all of them are
+// in flight. Total memory is NOT bounded: every pushed element is kept in memory until the
+// sorter is destroyed, nothing is spilled. What the sorter saves compared to buffering and
+// calling concurrent_sort is the full size scratch buffer, the sort scratch space is only
+// 2 * run_size elements per pool thread.
+//
+// push() and finish() block on pool tasks, so they must not be called from a pool worker.
+template<typename value_t>
+class stream_sorter {
+public:
+    typedef value_t value_type;
+
+    class iterator {
+    public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef value_t                 value_type;
+        typedef std::ptrdiff_t          difference_type;
+        typedef const value_t*          pointer;
+        typedef const value_t&          reference;
+
+        iterator() : _sorter(nullptr) {}
+        explicit iterator(stream_sorter* sorter) : _sorter(sorter->_merge_heap.empty() ? nullptr : sorter) {}
+
+        reference operator*()  const { return *_sorter->_merge_heap.front().current; }
+        pointer   operator->() const { return  _sorter->_merge_heap.front().current; }
+
+        iterator& operator++() {
+            _sorter->_merge_next();
+            if (_sorter->_merge_heap.empty()) {
+                _sorter = nullptr;
+            }
+            return *this;
+        }
+
+        bool operator==(const iterator& other) const { return _sorter == other._sorter; }
+        bool operator!=(const iterator& other) const { return _sorter != other._sorter; }
+
+    private:
+        stream_sorter* _sorter;
+    };
+
+    // Small runs get to the pool early, so sorting overlaps with ingestion even for small
+    // batches, at the price of a wider merge.
+    explicit stream_sorter(size_t run_size = 64 * 1024)
+        : _max_in_flight(std::max<size_t>(no_tbb::thread_pool::instance().num_threads(), 1))
+        , _run_size(std::max<size_t>(run_size, 1))
+        , _finished(false)
+    {}
+
+    stream_sorter(const stream_sorter&) = delete;
+    stream_sorter& operator=(const stream_sorter&) = delete;
+
+    ~stream_sorter() {
+        for (std::future<void>& f : _in_flight) {
+            f.wait();
+        }
+    }
+
+    template<typename iterator_t>
+    void push(iterator_t begin, iterator_t end) {
+        assert(!_finished);
+        for (; begin != end; ++begin) {
+            _pending.push_back(*begin);
+            if (_pending.size() == _run_size) {
+                _dispatch_pending();
+            }
+        }
+    }
+
+    void push(const std::vector<value_type>& chunk) {
+        push(chunk.begin(), chunk.end());
+    }
+
+    // Waits for the background sorts and prepares the merge. No pushes are allowed after.
+    void finish() {
+        assert(!_finished);
+        _finished = true;
+        _dispatch_pending();
+        while (!_in_flight.empty()) {
+            _wait_oldest();
+        }
+
+        for (const std::unique_ptr<run_type>& run : _runs) {
+            if (!run->empty()) {
+                _merge_heap.push_back(cursor{ run->data(), run->data() + run->size() });
+            }
+        }
+        std::make_heap(_merge_heap.begin(), _merge_heap.end(), cursor_greater());
+    }
+
+    // Sorted elements, valid after finish(). The sequence can be traversed only once.
+    iterator begin() { assert(_finished); return iterator(this); }
+    iterator end()   { return iterator(); }
+
+private:
+    typedef std::vector<value_type> run_type;
+
+    struct cursor {
+        const value_type* current;
+        const value_type* end;
+    };
+
+    struct cursor_greater {
+        bool operator()(const cursor& lhs, const cursor& rhs) const {
+            return detail::key_less<value_type>()(*rhs.current, *lhs.current);
+        }
+    };
+
+    void _dispatch_pending() {
+        if (_pending.empty()) {
+            return;
+        }
+        while (_in_flight.size() >= _max_in_flight) {
+            _wait_oldest();
+        }
+
+        _runs.emplace_back(new run_type());
+        run_type* run = _runs.back().get();
+        run->swap(_pending);
+        _pending.reserve(_run_size);
+
+        _in_flight.push_back(no_tbb::thread_pool::instance().async([run]() -> void {
+            radix_sort::sort(run->begin(), run->end());
+        }));
+    }
+
+    void _wait_oldest() {
+        std::future<void> oldest = std::move(_in_flight.front());
+        _in_flight.pop_front();
+        oldest.get();
+    }
+
+    void _merge_next() {
+        std::pop_heap(_merge_heap.begin(), _merge_heap.end(), cursor_greater());
+        cursor& c = _merge_heap.back();
+        if (++c.current == c.end) {
+            _merge_heap.pop_back();
+        } else {
+            std::push_heap(_merge_heap.begin(), _merge_heap.end(), cursor_greater());
+        }
+    }
+
+    const size_t                           _max_in_flight;
+    const size_t                           _run_size;
+    bool                                   _finished;
+    run_type                               _pending;
+    std::vector<std::unique_ptr<run_type> > _runs;
+    std::deque<std::future<void> >         _in_flight;
+    std::vector<cursor>                    _merge_heap;
+};
+
+}
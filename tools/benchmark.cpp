@@ -11,10 +11,25 @@
 #include <iomanip>
 #include <stdexcept>
 #include <map>
+#include <array>
+#include <utility>
+#include <tuple>
+#include <future>
+#include <type_traits>
 
 #include <radix_sort/sort.hpp>
+#include <radix_sort/async_sort.hpp>
 #include <radix_sort/concurrent_sort.hpp>
+#include <radix_sort/executors/serial_executor.hpp>
 #include <radix_sort/tbb_concurrent_sort.hpp>
+#include <radix_sort/openmp_concurrent_sort.hpp>
+#include <radix_sort/stream_sorter.hpp>
+#include <radix_sort/group_by.hpp>
+
+#if defined(TBB_FOUND)
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+#endif
 
 template<typename value_t>
 struct msvc_rnd_workaround {
@@ -30,23 +45,312 @@ struct msvc_rnd_workaround<uint8_t>
 };
 #endif
 
+template<typename value_t, typename enable_t = void>
+struct random_value;
+
+template<typename value_t>
+struct random_value<value_t, typename std::enable_if<std::is_integral<value_t>::value>::type> {
+    typedef typename msvc_rnd_workaround<value_t>::type rnd_value_type;
+
+    random_value()
+        : _uniform(std::numeric_limits<value_t>::min(), std::numeric_limits<value_t>::max())
+    {}
+
+    value_t operator()(std::mt19937& rng) { return static_cast<value_t>(_uniform(rng)); }
+
+private:
+    std::uniform_int_distribution<rnd_value_type> _uniform;
+};
+
+template<typename value_t>
+struct random_value<value_t, typename std::enable_if<std::is_floating_point<value_t>::value>::type> {
+    random_value()
+        : _uniform(-1e9, 1e9)
+    {}
+
+    // One in eight values is a zero of either sign, they have different bits but compare equal
+    value_t operator()(std::mt19937& rng) {
+        switch (rng() % 16) {
+        case 0:  return static_cast<value_t>(0);
+        case 1:  return -static_cast<value_t>(0);
+        default: return _uniform(rng);
+        }
+    }
+
+private:
+    std::uniform_real_distribution<value_t> _uniform;
+};
+
+#if defined(__SIZEOF_INT128__)
+template<>
+struct random_value<radix_sort::detail::uint128_t> {
+    radix_sort::detail::uint128_t operator()(std::mt19937& rng) {
+        return static_cast<radix_sort::detail::uint128_t>(_half(rng)) << 64 | _half(rng);
+    }
+
+private:
+    random_value<uint64_t> _half;
+};
+#endif
+
+template<typename first_t, typename second_t>
+struct random_value<std::pair<first_t, second_t> > {
+    std::pair<first_t, second_t> operator()(std::mt19937& rng) {
+        first_t first = _first(rng);
+        return std::make_pair(first, _second(rng));
+    }
+
+private:
+    random_value<first_t>  _first;
+    random_value<second_t> _second;
+};
+
+// The middle field is constant, so the sorts have to skip its pass
+template<>
+struct random_value<std::tuple<int16_t, uint8_t, int64_t> > {
+    std::tuple<int16_t, uint8_t, int64_t> operator()(std::mt19937& rng) {
+        int16_t first = _first(rng);
+        return std::make_tuple(first, static_cast<uint8_t>(42), _last(rng));
+    }
+
+private:
+    random_value<int16_t> _first;
+    random_value<int64_t> _last;
+};
+
+template<typename field_t, size_t size>
+struct random_value<std::array<field_t, size> > {
+    std::array<field_t, size> operator()(std::mt19937& rng) {
+        std::array<field_t, size> result;
+        for (field_t& field : result) {
+            field = _field(rng);
+        }
+        return result;
+    }
+
+private:
+    random_value<field_t> _field;
+};
+
 #if defined(__GLIBCXX__) && (__GLIBCXX__ < 20120322)
 typedef std::chrono::monotonic_clock steady_clock;
 #else
 typedef std::chrono::steady_clock steady_clock;
 #endif
 
+template<typename value_t>
+struct algorithms {
+    typedef typename std::vector<value_t>::iterator iterator_type;
+    typedef void (*algorithm_type)(iterator_type begin, iterator_type end);
+    typedef std::vector<std::pair<std::string, algorithm_type> > list_type;
+
+    static void serial_concurrent_sort(iterator_type begin, iterator_type end) {
+        radix_sort::concurrent_sort(radix_sort::serial_executor(), begin, end);
+    }
+
+    static void async_sort(iterator_type begin, iterator_type end) {
+        radix_sort::async_sort(begin, end).get();
+    }
+
+    static void stream_sort(iterator_type begin, iterator_type end) {
+        const size_t chunk_size = 64 * 1024;
+        radix_sort::stream_sorter<value_t> sorter;
+        for (iterator_type chunk_begin = begin; chunk_begin != end; ) {
+            iterator_type chunk_end = chunk_begin + std::min<size_t>(chunk_size, std::distance(chunk_begin, end));
+            sorter.push(chunk_begin, chunk_end);
+            chunk_begin = chunk_end;
+        }
+        sorter.finish();
+        std::copy(sorter.begin(), sorter.end(), begin);
+    }
+
+#if defined(TBB_FOUND)
+    // Sorts the halves from inside a tbb::parallel_for body and merges them, the executor
+    // has to share the workers of the enclosing loop.
+    static void tbb_nested_sort(iterator_type begin, iterator_type end) {
+        iterator_type middle = begin + std::distance(begin, end) / 2;
+        tbb::parallel_for(0, 2, [begin, middle, end](int half) -> void {
+            if (0 == half) {
+                radix_sort::tbb_concurrent_sort(begin, middle);
+            } else {
+                radix_sort::tbb_concurrent_sort(middle, end);
+            }
+        });
+        std::inplace_merge(begin, middle, end);
+    }
+
+    // Runs on an arena owned by the caller
+    static void tbb_arena_sort(iterator_type begin, iterator_type end) {
+        static tbb::task_arena arena;
+        radix_sort::concurrent_sort(radix_sort::tbb_executor(4, &arena), begin, end);
+    }
+#endif
+
+    // Batches are `batch_size` independent sorts of consecutive slices of the range, run to
+    // compare the throughput of sorts in flight together with the one of sorts back to back.
+    static const size_t batch_size = 8;
+
+    static void batch_slice(iterator_type begin, iterator_type end, size_t index, iterator_type& slice_begin, iterator_type& slice_end) {
+        size_t start, stop;
+        radix_sort::detail::chunk_bounds(0, static_cast<size_t>(std::distance(begin, end)), batch_size, index, start, stop);
+        slice_begin = begin + start;
+        slice_end   = begin + stop;
+    }
+
+    static void std_batch_sort(iterator_type begin, iterator_type end) {
+        for (size_t ii = 0; ii < batch_size; ++ii) {
+            iterator_type slice_begin, slice_end;
+            batch_slice(begin, end, ii, slice_begin, slice_end);
+            std::sort(slice_begin, slice_end);
+        }
+    }
+
+    static void concurrent_batch_sort(iterator_type begin, iterator_type end) {
+        for (size_t ii = 0; ii < batch_size; ++ii) {
+            iterator_type slice_begin, slice_end;
+            batch_slice(begin, end, ii, slice_begin, slice_end);
+            radix_sort::concurrent_sort(slice_begin, slice_end);
+        }
+    }
+
+    static void async_batch_sort(iterator_type begin, iterator_type end) {
+        std::vector<std::future<void> > sorts;
+        for (size_t ii = 0; ii < batch_size; ++ii) {
+            iterator_type slice_begin, slice_end;
+            batch_slice(begin, end, ii, slice_begin, slice_end);
+            sorts.push_back(radix_sort::async_sort(slice_begin, slice_end));
+        }
+        for (std::future<void>& sort : sorts) {
+            sort.get();
+        }
+    }
+
+    static const list_type& batch_list() {
+        static const list_type the_list {
+            { "8x_concurrent",  concurrent_batch_sort },
+            { "8x_async",       async_batch_sort      },
+        };
+        return the_list;
+    }
+
+    static const list_type& list() {
+        static const list_type the_list {
+            { "std::sort",      std::sort                  <iterator_type> },
+            { "radix_sort",     radix_sort::sort           <iterator_type> },
+            { "serial",         serial_concurrent_sort                     },
+            { "concurrent",     radix_sort::concurrent_sort<iterator_type> },
+            { "async",          async_sort                                 },
+            { "stream",         stream_sort                                },
+#if defined(_OPENMP)
+            { "omp_concurrent", radix_sort::openmp_concurrent_sort<iterator_type> },
+#endif
+#if defined(TBB_FOUND)
+            { "tbb_concurrent", radix_sort::tbb_concurrent_sort<iterator_type> },
+            { "tbb_nested",     tbb_nested_sort                                   },
+            { "tbb_arena",      tbb_arena_sort                                    },
+#endif
+        };
+        return the_list;
+    }
+
+    // Grouping algorithms sort and dedup `keys` in place, resize it to the number of distinct
+    // keys and, if `counts` is set for them, fill `counts` with the number of occurrences
+    typedef void (*grouping_type)(std::vector<value_t>& keys, std::vector<size_t>& counts);
+    struct grouping {
+        std::string   name;
+        grouping_type algorithm;
+        bool          counts;
+    };
+    typedef std::vector<grouping> grouping_list_type;
+
+    static void sort_unique(std::vector<value_t>& keys, std::vector<size_t>&) {
+        radix_sort::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    }
+
+    // What count_by_key replaces: a sort and a counting pass over the sorted keys
+    static void sort_count(std::vector<value_t>& keys, std::vector<size_t>& counts) {
+        radix_sort::sort(keys.begin(), keys.end());
+        size_t num_groups = 0;
+        for (size_t jj = 0; jj < keys.size(); ++jj) {
+            if (0 == num_groups || !(keys[num_groups - 1] == keys[jj])) {
+                keys[num_groups] = keys[jj];
+                counts[num_groups++] = 1;
+            } else {
+                counts[num_groups - 1]++;
+            }
+        }
+        keys.resize(num_groups);
+        counts.resize(num_groups);
+    }
+
+    static void unique(std::vector<value_t>& keys, std::vector<size_t>&) {
+        keys.erase(radix_sort::unique(keys.begin(), keys.end()), keys.end());
+    }
+
+    static void concurrent_unique(std::vector<value_t>& keys, std::vector<size_t>&) {
+        keys.erase(radix_sort::concurrent_unique(keys.begin(), keys.end()), keys.end());
+    }
+
+    static void count_by_key(std::vector<value_t>& keys, std::vector<size_t>& counts) {
+        keys.erase(radix_sort::count_by_key(keys.begin(), keys.end(), counts.begin()), keys.end());
+        counts.resize(keys.size());
+    }
+
+    static void concurrent_count_by_key(std::vector<value_t>& keys, std::vector<size_t>& counts) {
+        keys.erase(radix_sort::concurrent_count_by_key(keys.begin(), keys.end(), counts.begin()), keys.end());
+        counts.resize(keys.size());
+    }
+
+    // Counting expressed as a sum of ones, the time includes making the pairs
+    template<bool concurrent>
+    static void reduce_by_key(std::vector<value_t>& keys, std::vector<size_t>& counts) {
+        typedef std::vector<std::pair<value_t, size_t> > pair_vec_t;
+        pair_vec_t pairs;
+        pairs.reserve(keys.size());
+        for (const value_t& key : keys) {
+            pairs.emplace_back(key, 1);
+        }
+
+        typename pair_vec_t::iterator pairs_end = concurrent
+            ? radix_sort::concurrent_reduce_by_key(pairs.begin(), pairs.end(), std::plus<size_t>())
+            : radix_sort::reduce_by_key(pairs.begin(), pairs.end(), std::plus<size_t>());
+        pairs.erase(pairs_end, pairs.end());
+
+        keys.resize(pairs.size());
+        counts.resize(pairs.size());
+        for (size_t ii = 0; ii < pairs.size(); ++ii) {
+            keys[ii]   = pairs[ii].first;
+            counts[ii] = pairs[ii].second;
+        }
+    }
+
+    static const grouping_list_type& grouping_list() {
+        static const grouping_list_type the_list {
+            { "sort+unique",    sort_unique,             false },
+            { "unique",         unique,                  false },
+            { "c_unique",       concurrent_unique,       false },
+            { "sort+count",     sort_count,              true  },
+            { "count",          count_by_key,            true  },
+            { "c_count",        concurrent_count_by_key, true  },
+            { "reduce",         reduce_by_key<false>,    true  },
+            { "c_reduce",       reduce_by_key<true>,     true  },
+        };
+        return the_list;
+    }
+};
+
 template<typename value_t>
 struct experiment {
 
     experiment(size_t size)
         : _random_device()
         , _mersenne_twister(_random_device())
-        , _uniform(std::numeric_limits<value_t>::min(), std::numeric_limits<value_t>::max())
+        , _random_value()
         , _unsorted([size, this]() {
             std::vector<value_t> result;
             result.reserve(size);
-            std::generate_n(std::back_inserter(result), size, std::bind(_uniform, _mersenne_twister));
+            std::generate_n(std::back_inserter(result), size, [this]() { return _random_value(_mersenne_twister); });
             return std::move(result);
         }())
         , _gold_sorted([this]() {
@@ -54,14 +358,47 @@ struct experiment {
             std::sort(result.begin(), result.end());
             return std::move(result);
         }())
-        , _std_sort_msec                  (_sorting_experiment(std::sort                  <iterator_type>))
-        , _radix_sort_sort_msec           (_sorting_experiment(radix_sort::sort           <iterator_type>))
-        , _radix_sort_concurrent_sort_msec(_sorting_experiment(radix_sort::concurrent_sort<iterator_type>))
-#if defined(TBB_FOUND)
-        , _radix_sort_tbb_concurrent_sort_msec(_sorting_experiment(radix_sort::tbb_concurrent_sort<iterator_type>))
-#else
-        , _radix_sort_tbb_concurrent_sort_msec(0)
-#endif
+        , _msec([this]() {
+            std::vector<uint64_t> result;
+            for (const auto& algorithm : algorithms<value_t>::list()) {
+                result.push_back(_sorting_experiment(algorithm.second, _gold_sorted));
+            }
+            return result;
+        }())
+        , _gold_batch_sorted([this]() {
+            value_vec_t result = _unsorted;
+            algorithms<value_t>::std_batch_sort(result.begin(), result.end());
+            return result;
+        }())
+        , _batch_msec([this]() {
+            std::vector<uint64_t> result;
+            for (const auto& algorithm : algorithms<value_t>::batch_list()) {
+                result.push_back(_sorting_experiment(algorithm.second, _gold_batch_sorted));
+            }
+            return result;
+        }())
+        , _gold_unique([this]() {
+            value_vec_t result = _gold_sorted;
+            result.erase(std::unique(result.begin(), result.end()), result.end());
+            return result;
+        }())
+        , _gold_counts([this]() {
+            std::vector<size_t> result;
+            for (size_t ii = 0; ii < _gold_sorted.size(); ++ii) {
+                if (0 == ii || !(_gold_sorted[ii - 1] == _gold_sorted[ii])) {
+                    result.push_back(0);
+                }
+                ++result.back();
+            }
+            return result;
+        }())
+        , _grouping_msec([this]() {
+            std::vector<uint64_t> result;
+            for (const auto& grouping : algorithms<value_t>::grouping_list()) {
+                result.push_back(_grouping_experiment(grouping));
+            }
+            return result;
+        }())
     {}
 
     experiment(const experiment<value_t>&) = delete;
@@ -69,35 +406,49 @@ struct experiment {
 
 private:
     typedef std::vector<value_t> value_vec_t;
-    typedef typename std::vector<value_t>::iterator iterator_type;
+    typedef typename algorithms<value_t>::algorithm_type algorithm_type;
     
-    uint64_t _sorting_experiment(void (*algorithm)(iterator_type begin, iterator_type end) ) {
+    uint64_t _sorting_experiment(algorithm_type algorithm, const value_vec_t& gold_sorted) {
         value_vec_t sorted = _unsorted;
 
         std::chrono::time_point<steady_clock> begin = steady_clock::now();
         algorithm(sorted.begin(), sorted.end());
         std::chrono::time_point<steady_clock> end   = steady_clock::now();
 
-        if (sorted != _gold_sorted) {
+        if (sorted != gold_sorted) {
             throw std::logic_error("An implementation gave different results than std::sort");
         }
         
         return std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count();
     }
 
-    typedef typename msvc_rnd_workaround<value_t>::type rnd_value_type;
+    uint64_t _grouping_experiment(const typename algorithms<value_t>::grouping& grouping) {
+        value_vec_t         keys = _unsorted;
+        std::vector<size_t> counts(keys.size());
 
-    std::random_device                            _random_device;
-    std::mt19937                                  _mersenne_twister;
-    std::uniform_int_distribution<rnd_value_type> _uniform;
-    
-    const value_vec_t _unsorted;
-    const value_vec_t _gold_sorted;
+        std::chrono::time_point<steady_clock> begin = steady_clock::now();
+        grouping.algorithm(keys, counts);
+        std::chrono::time_point<steady_clock> end   = steady_clock::now();
 
-    const uint64_t    _std_sort_msec;
-    const uint64_t    _radix_sort_sort_msec;
-    const uint64_t    _radix_sort_concurrent_sort_msec;
-    const uint64_t    _radix_sort_tbb_concurrent_sort_msec;
+        if (keys != _gold_unique || (grouping.counts && counts != _gold_counts)) {
+            throw std::logic_error("An implementation gave different results than std::unique");
+        }
+
+        return std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count();
+    }
+
+    std::random_device       _random_device;
+    std::mt19937             _mersenne_twister;
+    random_value<value_t>    _random_value;
+    
+    const value_vec_t           _unsorted;
+    const value_vec_t           _gold_sorted;
+    const std::vector<uint64_t> _msec;
+    const value_vec_t           _gold_batch_sorted;
+    const std::vector<uint64_t> _batch_msec;
+    const value_vec_t           _gold_unique;
+    const std::vector<size_t>   _gold_counts;
+    const std::vector<uint64_t> _grouping_msec;
 
     template<typename other_value_t>
     friend std::ostream& operator<<(std::ostream &os, const experiment<other_value_t>& e);
@@ -106,13 +457,15 @@ private:
 
 template<typename value_t>
 std::ostream& operator<<(std::ostream& os, const experiment<value_t>& e) {
-    os << std::left << 
-        std::setw(15) << e._std_sort_msec <<
-        std::setw(15) << e._radix_sort_sort_msec <<
-        std::setw(15) << e._radix_sort_concurrent_sort_msec;
-#if defined(TBB_FOUND)
-    os << std::setw(15) << e._radix_sort_tbb_concurrent_sort_msec;
-#endif
+    for (uint64_t msec : e._msec) {
+        os << std::left << std::setw(15) << msec;
+    }
+    for (uint64_t msec : e._batch_msec) {
+        os << std::left << std::setw(15) << msec;
+    }
+    for (uint64_t msec : e._grouping_msec) {
+        os << std::left << std::setw(15) << msec;
+    }
     return os;
 }
 
@@ -124,15 +477,17 @@ struct benchmark_base {
 template<typename value_t>
 struct benchmark : public benchmark_base {
     virtual void go(size_t start, size_t stop, size_t step) {
-        std::cout << std::left << 
-            std::setw(15) << "#" << 
-            std::setw(15) << "std::sort" <<
-            std::setw(15) << "radix_sort" <<
-            std::setw(15) << "concurrent" <<
-#if defined(TBB_FOUND)
-            std::setw(15) << "tbb_concurrent" <<
-#endif
-            std::endl;
+        std::cout << std::left << std::setw(15) << "#";
+        for (const auto& algorithm : algorithms<value_t>::list()) {
+            std::cout << std::left << std::setw(15) << algorithm.first;
+        }
+        for (const auto& algorithm : algorithms<value_t>::batch_list()) {
+            std::cout << std::left << std::setw(15) << algorithm.first;
+        }
+        for (const auto& grouping : algorithms<value_t>::grouping_list()) {
+            std::cout << std::left << std::setw(15) << grouping.name;
+        }
+        std::cout << std::endl;
         for(size_t size = start; size < stop; size += step) {
             std::cout << std::left << std::setw(15) << size;
             const experiment<value_t> e(size);
@@ -156,10 +511,21 @@ try {
     }
     
     const std::map<std::string, benchmark_base* > benchmarks {
-        { "uint8_t",  new benchmark<uint8_t>()  },
-        { "uint16_t", new benchmark<uint16_t>() },
-        { "uint32_t", new benchmark<uint32_t>() },
-        { "uint64_t", new benchmark<uint64_t>() }
+        { "uint8_t",          new benchmark<uint8_t>()                                },
+        { "uint16_t",         new benchmark<uint16_t>()                               },
+        { "uint32_t",         new benchmark<uint32_t>()                               },
+        { "uint64_t",         new benchmark<uint64_t>()                               },
+        { "int32_t",          new benchmark<int32_t>()                                },
+        { "int64_t",          new benchmark<int64_t>()                                },
+        { "float",            new benchmark<float>()                                  },
+        { "double",           new benchmark<double>()                                 },
+#if defined(__SIZEOF_INT128__)
+        { "uint128_t",        new benchmark<radix_sort::detail::uint128_t>()          },
+#endif
+        { "pair_u16_u64",     new benchmark<std::pair<uint16_t, uint64_t> >()         },
+        { "pair_f64_i32",     new benchmark<std::pair<double, int32_t> >()            },
+        { "tuple_i16_u8_i64", new benchmark<std::tuple<int16_t, uint8_t, int64_t> >() },
+        { "array_u8_16",      new benchmark<std::array<uint8_t, 16> >()               }
     };
 
     std::string arithm = argv[1];
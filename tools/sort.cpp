@@ -8,6 +8,7 @@
 #include <radix_sort/sort.hpp>
 #include <radix_sort/concurrent_sort.hpp>
 #include <radix_sort/tbb_concurrent_sort.hpp>
+#include <radix_sort/openmp_concurrent_sort.hpp>
 
 
 struct sorter_base {
@@ -40,7 +41,9 @@ int main(int argc, char** argv) {
         { "uint8_t",  new sorter<uint8_t>()  },
         { "uint16_t", new sorter<uint16_t>() },
         { "uint32_t", new sorter<uint32_t>() },
-        { "uint64_t", new sorter<uint64_t>() }
+        { "uint64_t", new sorter<uint64_t>() },
+        { "int32_t",  new sorter<int32_t>()  },
+        { "int64_t",  new sorter<int64_t>()  }
     };
     std::string arithm = "uint32_t";
     if (argc > 1) {